@@ -1,12 +1,27 @@
 #include "shared_memory.h"
+#include "perf_counters.h"
 
 int main(int argc, char *argv[]) {
     // Validar argumentos
-    if (argc != 3) {
-        fprintf(stderr, "Uso: %s <'manual' | milisegundos> <llave_8bits>\n", argv[0]);
+    if (argc < 3 || argc > 5) {
+        fprintf(stderr, "Uso: %s <'manual' | milisegundos> <llave_8bits> [perf] [urgente]\n", argv[0]);
         return EXIT_FAILURE;
     }
 
+    // Opciones adicionales
+    int use_perf = 0;
+    int is_urgent = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "perf") == 0) {
+            use_perf = 1;
+        } else if (strcmp(argv[i], "urgente") == 0) {
+            is_urgent = 1;
+        } else {
+            fprintf(stderr, "Opción desconocida: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
     // Modo manual o automático
     int is_manual = (strcmp(argv[1], "manual") == 0);
     long delay_ms = 0;
@@ -21,35 +36,12 @@ int main(int argc, char *argv[]) {
     // Llave de cifrado
     char key = (char)atoi(argv[2]);
 
-    // Abrir memoria compartida existente
-    int shm_fd = shm_open(SHM_NAME, O_RDWR, 0666);
-    if (shm_fd == -1) {
-        perror("Emisor: shm_open falló");
-        return EXIT_FAILURE;
-    }
-
-    // Mapeo temporal para obtener tamaño real
-    shared_data* temp_map = mmap(0, sizeof(shared_data), PROT_READ, MAP_SHARED, shm_fd, 0);
-    if (temp_map == MAP_FAILED) {
-        perror("Emisor: mmap temporal falló");
-        close(shm_fd);
-        return EXIT_FAILURE;
-    }
-
-    // Calcular tamaño total de la memoria
-    size_t shm_size = sizeof(shared_data)
-        + temp_map->buffer_size * sizeof(buffer_entry)
-        + temp_map->buffer_size * sizeof(sem_t);
-    munmap(temp_map, sizeof(shared_data));
-
-    // Mapeo completo
-    shared_data *data = mmap(0, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-    if (data == MAP_FAILED) {
-        perror("Emisor: mmap final falló");
-        close(shm_fd);
+    // Abrir y mapear la memoria compartida existente
+    size_t shm_size;
+    shared_data *data = map_shared_data(SHM_NAME, "Emisor", &shm_size);
+    if (!data) {
         return EXIT_FAILURE;
     }
-    close(shm_fd);
 
     // Manejador de señal para cierre limpio
     signal(SIGTERM, sigterm_handler);
@@ -61,14 +53,29 @@ int main(int argc, char *argv[]) {
     sem_post(&data->producer_mutex);
 
     int my_source_index = 0; // Índice local del archivo fuente
+    long sent_chars = 0;     // Caracteres enviados por este emisor
 
-    printf("Emisor (PID %d) iniciado en modo: %s\n", getpid(), is_manual ? "Manual" : "Automático");
+    // Copias de los eventfd de receptores que los registraron
+    notify_cache notify_fds;
+    if (notify_cache_init(&notify_fds, data->max_receivers) == -1) {
+        fprintf(stderr, "Emisor: sin memoria para los eventfd, solo se usarán semáforos\n");
+    }
+
+    printf("Emisor (PID %d) iniciado en modo: %s%s\n", getpid(),
+           is_manual ? "Manual" : "Automático", is_urgent ? " (carril urgente)" : "");
     
     if (is_manual) {
         printf("%sPresione %sENTER%s para enviar caracteres.%s\n\n", 
                COLOR_INFO, COLOR_WARNING, COLOR_INFO, COLOR_RESET);
     }
 
+    // Contadores de rendimiento opcionales
+    perf_counters perf;
+    if (use_perf) perf_counters_start(&perf);
+
+    // El carril urgente tiene sus propios espacios, nunca espera al búfer principal
+    sem_t* free_slots = is_urgent ? &data->urgent_empty_slots : &data->empty_slots;
+
     while (keep_running && !data->shutdown_requested) {
         int slot_reservado = 0;
 
@@ -78,57 +85,82 @@ int main(int argc, char *argv[]) {
         }
         
         // Esperar espacio libre
-        if (sem_wait(&data->empty_slots) == -1) {
+        if (sem_wait(free_slots) == -1) {
             if (keep_running && !data->shutdown_requested) perror("sem_wait empty_slots");
             break;
         }
         slot_reservado = 1;
 
         if (!keep_running || data->shutdown_requested) {
-            if(slot_reservado) sem_post(&data->empty_slots);
+            if(slot_reservado) sem_post(free_slots);
             break;
         }
 
         // Leer siguiente caracter del origen
         if (my_source_index >= data->source_size) {
             printf("Emisor (PID %d): Fin del archivo.\n", getpid());
-            if(slot_reservado) sem_post(&data->empty_slots);
+            if(slot_reservado) sem_post(free_slots);
             break;
         }
         char original_char = data->source_content[my_source_index++];
         
+        // Obtener eventfd de receptores nuevos antes de tomar el registro
+        notify_cache_refresh(&notify_fds, data);
+
         // Bloquear acceso a la lista de receptores
         sem_wait(&data->receiver_registry_mutex);
 
-        // Obtener índice de escritura
-        sem_wait(&data->producer_mutex);
-        int write_idx = data->write_index;
-        data->write_index = (data->write_index + 1) % data->buffer_size;
-        sem_post(&data->producer_mutex);
-
-        // Obtener semáforo del slot
-        sem_t* slot_mutexes = get_slot_mutexes(data);
-        sem_wait(&slot_mutexes[write_idx]);
-
-        // Escribir datos cifrados en el buffer
-        data->buffer[write_idx].ascii_val = original_char ^ key;
-        data->buffer[write_idx].index = write_idx;
-        data->buffer[write_idx].read_count = data->active_receivers;
-        time(&data->buffer[write_idx].timestamp);
-
-        // Mostrar información
-        print_char_info("Emisor", getpid(), original_char, write_idx, data->buffer[write_idx].timestamp);
-
-        sem_post(&slot_mutexes[write_idx]);
+        if (is_urgent) {
+            // Escribir en el carril urgente
+            sem_wait(&data->urgent_mutex);
+            int write_idx = data->urgent_write_index;
+            data->urgent_write_index = (data->urgent_write_index + 1) % PRIORITY_LANE_SIZE;
+
+            buffer_entry* entry = &data->urgent_buffer[write_idx];
+            entry->ascii_val = original_char ^ key;
+            entry->index = write_idx;
+            entry->read_count = data->active_receivers;
+            time(&entry->timestamp);
+            entry->publish_ns = monotonic_ns();
+
+            print_char_info("Emisor", getpid(), original_char, write_idx, entry->timestamp);
+            printf("      * Carril urgente.\n");
+            sem_post(&data->urgent_mutex);
+        } else {
+            // Obtener índice de escritura
+            sem_wait(&data->producer_mutex);
+            int write_idx = data->write_index;
+            data->write_index = (data->write_index + 1) % data->buffer_size;
+            sem_post(&data->producer_mutex);
+
+            // Obtener semáforo del slot
+            sem_t* slot_mutexes = get_slot_mutexes(data);
+            sem_wait(&slot_mutexes[write_idx]);
+
+            // Escribir datos cifrados en el buffer
+            data->buffer[write_idx].ascii_val = original_char ^ key;
+            data->buffer[write_idx].index = write_idx;
+            data->buffer[write_idx].read_count = data->active_receivers;
+            time(&data->buffer[write_idx].timestamp);
+            data->buffer[write_idx].publish_ns = monotonic_ns();
+
+            // Mostrar información
+            print_char_info("Emisor", getpid(), original_char, write_idx, data->buffer[write_idx].timestamp);
+
+            sem_post(&slot_mutexes[write_idx]);
+        }
         data->total_chars_transferred++;
+        sent_chars++;
 
         // Notificar a receptores o liberar slot
         if (data->active_receivers == 0) {
-            sem_post(&data->empty_slots);
+            sem_post(free_slots);
         } else {
-            for (int i = 0; i < MAX_RECEIVERS; i++) {
-                if (data->receivers[i].pid != 0) {
-                    sem_post(&data->receivers[i].data_available);
+            // El costo depende del abanico del anillo, no del total de receptores hoja
+            receiver_info* receivers = get_receivers(data);
+            for (int i = 0; i < data->max_receivers; i++) {
+                if (receivers[i].pid != 0) {
+                    notify_new_entry(&notify_fds, &receivers[i], i, is_urgent);
                 }
             }
         }
@@ -144,12 +176,16 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Publicar estadísticas antes de avisar al finalizador
+    if (use_perf) perf_counters_stop(&perf, data, 1, sent_chars);
+
     // Actualizar contadores al salir
     sem_wait(&data->producer_mutex);
     data->active_emitters--;
     sem_post(&data->producer_mutex);
 
     sem_post(&data->process_finished);
+    notify_cache_close(&notify_fds);
 
     printf("Emisor (PID %d) finalizando.\n", getpid());
     munmap(data, shm_size);
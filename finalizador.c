@@ -1,4 +1,5 @@
 #include "shared_memory.h"
+#include "perf_counters.h"
 
 int main(int argc, char *argv[]) {
     (void)argc;
@@ -8,34 +9,13 @@ int main(int argc, char *argv[]) {
     printf("Para iniciar el proceso de finalización presione Ctrl+C.\n");
     signal(SIGINT, sigterm_handler);
     
-    // Abrir memoria compartida existente
-    int shm_fd = shm_open(SHM_NAME, O_RDWR, 0666);
-    if (shm_fd == -1) {
-        perror("Finalizador: shm_open falló");
+    // Abrir y mapear la memoria compartida existente
+    size_t shm_size;
+    shared_data *data = map_shared_data(SHM_NAME, "Finalizador", &shm_size);
+    if (!data) {
         return EXIT_FAILURE;
     }
     
-    // Mapeo temporal para calcular tamaño real
-    shared_data* temp_map = mmap(0, sizeof(shared_data), PROT_READ, MAP_SHARED, shm_fd, 0);
-    if (temp_map == MAP_FAILED) {
-        perror("Finalizador: mmap temporal falló");
-        close(shm_fd);
-        return EXIT_FAILURE;
-    }
-    size_t shm_size = sizeof(shared_data) 
-                    + temp_map->buffer_size * sizeof(buffer_entry)
-                    + temp_map->buffer_size * sizeof(sem_t);
-    munmap(temp_map, sizeof(shared_data));
-    
-    // Mapeo completo de la memoria
-    shared_data *data = mmap(0, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-    if (data == MAP_FAILED) {
-        perror("Finalizador: mmap final falló");
-        close(shm_fd);
-        return EXIT_FAILURE;
-    }
-    close(shm_fd);
-    
     // Esperar señal de interrupción 
     while (keep_running) {
         pause();
@@ -45,22 +25,30 @@ int main(int argc, char *argv[]) {
 
     data->shutdown_requested = 1; // Avisar a todos que deben cerrar
 
-    // Despertar receptores dormidos y enviarles SIGTERM
+    // Despertar receptores dormidos y enviarles SIGTERM.
+    // Los relevos propagan el apagado a sus anillos hijos.
+    notify_cache notify_fds;
+    notify_cache_init(&notify_fds, data->max_receivers);
+    receiver_info* receivers = get_receivers(data);
     sem_wait(&data->receiver_registry_mutex);
     int total_processes = data->active_emitters + data->active_receivers;
-    for (int i = 0; i < MAX_RECEIVERS; i++) {
-        if (data->receivers[i].pid != 0) {
-            sem_post(&data->receivers[i].data_available);
-            kill(data->receivers[i].pid, SIGTERM);
+    for (int i = 0; i < data->max_receivers; i++) {
+        if (receivers[i].pid != 0) {
+            notify_receiver(&notify_fds, &receivers[i], i);
+            kill(receivers[i].pid, SIGTERM);
         }
     }
     sem_post(&data->receiver_registry_mutex);
+    notify_cache_close(&notify_fds);
     
     // Despertar emisores bloqueados por falta de espacio
     int buffer_size = data->buffer_size;
     for (int i = 0; i < buffer_size; ++i) {
         sem_post(&data->empty_slots);
     }
+    for (int i = 0; i < PRIORITY_LANE_SIZE; ++i) {
+        sem_post(&data->urgent_empty_slots);
+    }
     
     // Enviar SIGTERM a los procesos emisor
     system("pkill -SIGTERM emisor 2>/dev/null");
@@ -89,27 +77,52 @@ int main(int argc, char *argv[]) {
     printf("  * Caracteres transferidos: \033[0;32m%ld\033[0m\n", data->total_chars_transferred);
     printf("  * Emisores activos al finalizar: \033[0;31m%d\033[0m\n", data->active_emitters);
     printf("  * Receptores activos al finalizar: \033[0;31m%d\033[0m\n", data->active_receivers);
+
+    // Costos por carácter de los procesos iniciados con 'perf'
+    int stats_count = data->stats_count < MAX_STATS ? data->stats_count : MAX_STATS;
+    int any_llc_generic = 0;
+    if (stats_count > 0) {
+        printf("\n  \033[1mCosto por carácter:\033[0m\n");
+        printf("  %-8s %7s %7s %10s %10s %9s %8s %8s %10s  %s\n",
+               "Rol", "PID", "Chars", "Ciclos", "Instr", "LLC miss", "Cambios", "Fallos", "CPU (us)", "Modo HW");
+        for (int i = 0; i < stats_count; i++) {
+            process_stats* st = &data->stats[i];
+            double n = st->chars > 0 ? (double)st->chars : 1.0;
+            printf("  %-8s %7d %7ld ", st->is_emitter ? "Emisor" : "Receptor", st->pid, st->chars);
+
+            // Cada contador de hardware se reporta solo si se pudo abrir
+            if (st->counters_open & (1 << PERF_CYCLES)) printf("%10.1f ", st->cycles / n);
+            else printf("%10s ", "n/d");
+            if (st->counters_open & (1 << PERF_INSTRUCTIONS)) printf("%10.1f ", st->instructions / n);
+            else printf("%10s ", "n/d");
+            if (st->counters_open & (1 << PERF_LLC_MISSES)) {
+                printf("%8.2f%s ", st->llc_misses / n, st->llc_generic ? "*" : " ");
+                any_llc_generic |= st->llc_generic;
+            } else {
+                printf("%9s ", "n/d");
+            }
+            printf("%8.2f %8.2f %10.2f  ",
+                   st->context_switches / n, st->page_faults / n, st->cpu_time_ns / n / 1000.0);
+
+            // Modo en que se contaron los eventos de hardware abiertos
+            int hw_open = st->counters_open & ((1 << PERF_CYCLES) | (1 << PERF_INSTRUCTIONS) | (1 << PERF_LLC_MISSES));
+            int hw_user = st->user_only & hw_open;
+            if (hw_open == 0) printf("-\n");
+            else if (hw_user == 0) printf("usuario+kernel\n");
+            else if (hw_user == hw_open) printf("solo usuario\n");
+            else printf("mixto\n");
+        }
+        if (any_llc_generic) {
+            printf("  * Evento genérico de fallos de caché; según el CPU puede no ser la LLC.\n");
+        }
+    }
     printf("\033[1;36m⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻⸻\033[0m\n");
 
     printf("\nProcedo a liberar recursos del sistema.\n");
     
-    // Destruir semáforos 
-    sem_destroy(&data->empty_slots);
-    sem_destroy(&data->producer_mutex);
-    sem_destroy(&data->receiver_registry_mutex);
-    sem_destroy(&data->process_finished);
-    
-    // Destruir semáforos de receptores
-    for (int i = 0; i < MAX_RECEIVERS; ++i) {
-        sem_destroy(&data->receivers[i].data_available);
-    }
+    // Destruir semáforos
+    destroy_shared_data(data);
 
-    // Destruir semáforos por cada slot del búfer
-    sem_t* slot_mutexes = get_slot_mutexes(data);
-    for (int i = 0; i < buffer_size; ++i) {
-        sem_destroy(&slot_mutexes[i]);
-    }
-    
     // Liberar memoria compartida
     munmap(data, shm_size);
     shm_unlink(SHM_NAME);
@@ -0,0 +1,150 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include "shared_memory.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+
+// Eventos que se miden por proceso
+enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_CONTEXT_SWITCHES,
+    PERF_PAGE_FAULTS,
+    PERF_NUM_EVENTS
+};
+
+// Descriptores abiertos y valores iniciales para el respaldo por software
+typedef struct {
+    int fd[PERF_NUM_EVENTS];
+    int user_only;      // Bits de los eventos abiertos solo en modo usuario
+    int llc_generic;    // LLC medido con el evento genérico de fallos de caché
+    struct rusage usage_start;
+    struct timespec cpu_start;
+} perf_counters;
+
+static inline int perf_open_event(unsigned int type, unsigned long long config, int user_only) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = user_only;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Abre un evento de hardware contando también el kernel, donde ocurren los
+// futex, eventfd y epoll; si perf_event_paranoid lo impide, solo modo usuario
+static inline int perf_open_hw_event(perf_counters* pc, int event, unsigned int type,
+                                     unsigned long long config) {
+    int fd = perf_open_event(type, config, 0);
+    if (fd == -1 && (errno == EACCES || errno == EPERM)) {
+        fd = perf_open_event(type, config, 1);
+        if (fd != -1) pc->user_only |= 1 << event;
+    }
+    return fd;
+}
+
+// Abre los contadores; los que no estén disponibles quedan en -1
+static inline void perf_counters_start(perf_counters* pc) {
+    pc->user_only = 0;
+    pc->llc_generic = 0;
+    pc->fd[PERF_CYCLES] = perf_open_hw_event(pc, PERF_CYCLES,
+        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    pc->fd[PERF_INSTRUCTIONS] = perf_open_hw_event(pc, PERF_INSTRUCTIONS,
+        PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+
+    // Fallos de lectura en la caché de último nivel; si la PMU no lo ofrece,
+    // el evento genérico de fallos de caché (su significado depende del CPU)
+    pc->fd[PERF_LLC_MISSES] = perf_open_hw_event(pc, PERF_LLC_MISSES, PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_LL
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    if (pc->fd[PERF_LLC_MISSES] == -1) {
+        pc->fd[PERF_LLC_MISSES] = perf_open_hw_event(pc, PERF_LLC_MISSES,
+            PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        pc->llc_generic = pc->fd[PERF_LLC_MISSES] != -1;
+    }
+
+    pc->fd[PERF_CONTEXT_SWITCHES] = perf_open_event(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, 0);
+    pc->fd[PERF_PAGE_FAULTS] = perf_open_event(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, 0);
+
+    if (pc->fd[PERF_CYCLES] == -1 || pc->fd[PERF_INSTRUCTIONS] == -1 || pc->fd[PERF_LLC_MISSES] == -1) {
+        printf("%sAlgunos contadores de hardware no están disponibles.%s\n",
+               COLOR_WARNING, COLOR_RESET);
+    }
+
+    getrusage(RUSAGE_SELF, &pc->usage_start);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &pc->cpu_start);
+
+    for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+        if (pc->fd[i] != -1) {
+            ioctl(pc->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+static inline unsigned long long perf_read_event(int fd) {
+    unsigned long long value = 0;
+    if (fd == -1 || read(fd, &value, sizeof(value)) != sizeof(value)) return 0;
+    return value;
+}
+
+// Detiene los contadores y publica el resultado en el bloque de estadísticas
+static inline void perf_counters_stop(perf_counters* pc, shared_data* data, int is_emitter, long chars) {
+    for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+        if (pc->fd[i] != -1) ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    struct rusage usage_end;
+    struct timespec cpu_end;
+    getrusage(RUSAGE_SELF, &usage_end);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+
+    int slot = __sync_fetch_and_add(&data->stats_count, 1);
+    if (slot < MAX_STATS) {
+        process_stats* st = &data->stats[slot];
+        st->pid = getpid();
+        st->is_emitter = is_emitter;
+        st->counters_open = 0;
+        for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+            if (pc->fd[i] != -1) st->counters_open |= 1 << i;
+        }
+        st->user_only = pc->user_only;
+        st->llc_generic = pc->llc_generic;
+        st->chars = chars;
+        st->cycles = perf_read_event(pc->fd[PERF_CYCLES]);
+        st->instructions = perf_read_event(pc->fd[PERF_INSTRUCTIONS]);
+        st->llc_misses = perf_read_event(pc->fd[PERF_LLC_MISSES]);
+
+        // Eventos de software: si perf no los dio, usar getrusage
+        if (pc->fd[PERF_CONTEXT_SWITCHES] != -1) {
+            st->context_switches = perf_read_event(pc->fd[PERF_CONTEXT_SWITCHES]);
+        } else {
+            st->context_switches = (usage_end.ru_nvcsw - pc->usage_start.ru_nvcsw)
+                                 + (usage_end.ru_nivcsw - pc->usage_start.ru_nivcsw);
+        }
+        if (pc->fd[PERF_PAGE_FAULTS] != -1) {
+            st->page_faults = perf_read_event(pc->fd[PERF_PAGE_FAULTS]);
+        } else {
+            st->page_faults = (usage_end.ru_minflt - pc->usage_start.ru_minflt)
+                            + (usage_end.ru_majflt - pc->usage_start.ru_majflt);
+        }
+        st->cpu_time_ns = (cpu_end.tv_sec - pc->cpu_start.tv_sec) * 1000000000ULL
+                        + (cpu_end.tv_nsec - pc->cpu_start.tv_nsec);
+    } else {
+        fprintf(stderr, "No hay espacio para más estadísticas (max %d)\n", MAX_STATS);
+    }
+
+    for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+        if (pc->fd[i] != -1) close(pc->fd[i]);
+        pc->fd[i] = -1;
+    }
+}
+
+#endif // PERF_COUNTERS_H
@@ -1,11 +1,103 @@
 #include "shared_memory.h"
+#include "perf_counters.h"
+#include <pthread.h>
+#include <sys/epoll.h>
+
+// Descriptores que usa el hilo que entrega el eventfd a los emisores
+typedef struct {
+    int listen_fd;
+    int event_fd;
+} eventfd_server;
+
+// Entrega el eventfd por SCM_RIGHTS a cada emisor que se conecte.
+// Corre aparte para no depender de que el bucle principal esté en epoll.
+static void* serve_eventfd(void* arg) {
+    eventfd_server* srv = arg;
+    for (;;) {
+        int conn = accept4(srv->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (conn == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break; // shutdown() del socket al finalizar
+        }
+
+        // Solo procesos del mismo usuario reciben el eventfd
+        if (check_peer_cred(conn, 0) == -1) {
+            close(conn);
+            continue;
+        }
+
+        char byte = 0;
+        struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+        union {
+            char buf[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct msghdr msg = {
+            .msg_iov = &iov, .msg_iovlen = 1,
+            .msg_control = control.buf, .msg_controllen = sizeof(control.buf)
+        };
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &srv->event_fd, sizeof(int));
+
+        if (sendmsg(conn, &msg, MSG_NOSIGNAL) == -1) perror("Receptor: sendmsg eventfd");
+        close(conn);
+    }
+    return NULL;
+}
+
+// Espera un dato del slot. Con eventfd se bloquea en epoll y el semáforo
+// solo lleva la cuenta, así el mismo epoll puede vigilar otros descriptores.
+static int wait_for_data(receiver_info* me, int epoll_fd, int event_fd) {
+    if (event_fd == -1) return sem_wait(&me->data_available);
+
+    while (sem_trywait(&me->data_available) == -1) {
+        if (errno != EAGAIN) return -1;
+
+        // Un emisor no pudo obtener el eventfd: solo el semáforo es confiable
+        if (me->notify_fallback) return sem_wait(&me->data_available);
+
+        // Espera acotada por si la marca de respaldo llegó estando ya en epoll
+        struct epoll_event ev;
+        int n = epoll_wait(epoll_fd, &ev, 1, NOTIFY_RECHECK_MS);
+        if (n == -1) {
+            if (errno == EINTR && keep_running) continue;
+            return -1;
+        }
+
+        // Vaciar el contador; la cantidad real la lleva el semáforo
+        uint64_t count;
+        if (n > 0 && read(event_fd, &count, sizeof(count)) == -1 && errno != EAGAIN) return -1;
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[]) {
     // Validar argumentos
-    if (argc != 3) {
-        fprintf(stderr, "Uso: %s <'manual' | milisegundos> <llave_8bits>\n", argv[0]);
+    if (argc < 3 || argc > 6) {
+        fprintf(stderr, "Uso: %s <'manual' | milisegundos> <llave_8bits> [eventfd] [perf] [anillo=<nombre>]\n", argv[0]);
         return EXIT_FAILURE;
     }
+
+    // Opciones adicionales
+    int use_eventfd = 0;
+    int use_perf = 0;
+    const char* ring_name = SHM_NAME;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "eventfd") == 0) {
+            use_eventfd = 1;
+        } else if (strcmp(argv[i], "perf") == 0) {
+            use_perf = 1;
+        } else if (strncmp(argv[i], "anillo=", 7) == 0 && argv[i][7] != '\0') {
+            ring_name = argv[i] + 7;
+        } else {
+            fprintf(stderr, "Opción desconocida: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
     
     // Determinar modo de ejecución
     int is_manual = (strcmp(argv[1], "manual") == 0);
@@ -20,35 +112,15 @@ int main(int argc, char *argv[]) {
     char key = (char)atoi(argv[2]);
     
     int my_slot = -1; // Posición del receptor en la tabla
+    long received_chars = 0; // Caracteres leídos por este receptor
 
-    // Abrir memoria compartida existente
-    int shm_fd = shm_open(SHM_NAME, O_RDWR, 0666);
-    if (shm_fd == -1) {
-        perror("Receptor: shm_open falló");
-        return EXIT_FAILURE;
-    }
-
-    // Mapeo temporal para conocer tamaño total
-    shared_data* temp_map = mmap(0, sizeof(shared_data), PROT_READ, MAP_SHARED, shm_fd, 0);
-    if (temp_map == MAP_FAILED) {
-        perror("Receptor: mmap temporal falló");
-        close(shm_fd);
+    // Abrir y mapear el anillo (raíz o hijo de un relevo)
+    size_t shm_size;
+    shared_data *data = map_shared_data(ring_name, "Receptor", &shm_size);
+    if (!data) {
         return EXIT_FAILURE;
     }
-
-    size_t shm_size = sizeof(shared_data)
-        + temp_map->buffer_size * sizeof(buffer_entry)
-        + temp_map->buffer_size * sizeof(sem_t);
-    munmap(temp_map, sizeof(shared_data));
-
-    // Mapeo completo con permisos de lectura/escritura
-    shared_data *data = mmap(0, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-    if (data == MAP_FAILED) {
-        perror("Receptor: mmap final falló");
-        close(shm_fd);
-        return EXIT_FAILURE;
-    }
-    close(shm_fd);
+    receiver_info* receivers = get_receivers(data);
 
     // Manejar señal de terminación
     signal(SIGTERM, sigterm_handler);
@@ -63,14 +135,56 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
+    // Modo eventfd: los emisores piden el fd por un socket Unix y lo escriben
+    int event_fd = -1;
+    int epoll_fd = -1;
+    eventfd_server server = { .listen_fd = -1, .event_fd = -1 };
+    pthread_t server_thread;
+    if (use_eventfd) {
+        event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        server.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        server.event_fd = event_fd;
+        struct epoll_event ev = { .events = EPOLLIN, .data.fd = event_fd };
+        struct sockaddr_un addr;
+        socklen_t addr_len = notify_socket_addr(getpid(), &addr);
+
+        // SIGTERM lo atiende solo el hilo principal para que interrumpa epoll_wait
+        sigset_t term_set, old_set;
+        sigemptyset(&term_set);
+        sigaddset(&term_set, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &term_set, &old_set);
+
+        int failed = event_fd == -1 || epoll_fd == -1 || server.listen_fd == -1
+            || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &ev) == -1
+            || bind(server.listen_fd, (struct sockaddr*)&addr, addr_len) == -1
+            || listen(server.listen_fd, 16) == -1
+            || (errno = pthread_create(&server_thread, NULL, serve_eventfd, &server)) != 0;
+        pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+
+        if (failed) {
+            perror("Receptor: no se pudo preparar eventfd/epoll");
+            if (event_fd != -1) close(event_fd);
+            if (epoll_fd != -1) close(epoll_fd);
+            if (server.listen_fd != -1) close(server.listen_fd);
+            fclose(output_file);
+            munmap(data, shm_size);
+            return EXIT_FAILURE;
+        }
+    }
+
     // Registrar el receptor en la memoria compartida
     sem_wait(&data->receiver_registry_mutex);
-    for (int i = 0; i < MAX_RECEIVERS; ++i) {
-        if (data->receivers[i].pid == 0) {
+    for (int i = 0; i < data->max_receivers; ++i) {
+        if (receivers[i].pid == 0) {
             my_slot = i;
-            data->receivers[i].pid = getpid();
-            data->receivers[i].read_index = data->write_index;
-            data->receivers[i].is_manual = is_manual;
+            receivers[i].uses_eventfd = use_eventfd;
+            receivers[i].split_lanes = 0;
+            receivers[i].notify_fallback = 0;
+            receivers[i].pid = getpid();
+            receivers[i].read_index = data->write_index;
+            receivers[i].urgent_read_index = data->urgent_write_index;
+            receivers[i].is_manual = is_manual;
             break;
         }
     }
@@ -83,19 +197,31 @@ int main(int argc, char *argv[]) {
     // Se sale si noy espacio
     if (my_slot == -1) {
         fprintf(stderr, "No hay slots disponibles para receptores\n");
+        if (use_eventfd) {
+            shutdown(server.listen_fd, SHUT_RDWR);
+            pthread_join(server_thread, NULL);
+            close(server.listen_fd);
+        }
+        if (event_fd != -1) close(event_fd);
+        if (epoll_fd != -1) close(epoll_fd);
         fclose(output_file);
         munmap(data, shm_size);
         return EXIT_FAILURE;
     }
 
-    printf("Receptor (PID %d) en modo %s. Escribiendo a %s\n",
-           getpid(), is_manual ? "Manual" : "Automático", filename);
+    printf("Receptor (PID %d) en modo %s%s. Escribiendo a %s\n",
+           getpid(), is_manual ? "Manual" : "Automático",
+           use_eventfd ? " (eventfd)" : "", filename);
 
     if (is_manual) {
         printf("%sPresione %sENTER%s para leer caracteres.%s\n\n", 
                COLOR_INFO, COLOR_WARNING, COLOR_INFO, COLOR_RESET);
     }
 
+    // Contadores de rendimiento opcionales
+    perf_counters perf;
+    if (use_perf) perf_counters_start(&perf);
+
     // Bucle principal
     while (keep_running && !data->shutdown_requested) {
         // Espera manual
@@ -104,46 +230,69 @@ int main(int argc, char *argv[]) {
         }
 
         // Esperar dato disponible
-        if (sem_wait(&data->receivers[my_slot].data_available) == -1) {
+        if (wait_for_data(&receivers[my_slot], epoll_fd, event_fd) == -1) {
             if (keep_running && !data->shutdown_requested) perror("sem_wait data_available");
             break;
         }
         if (!keep_running || data->shutdown_requested) break;
 
-        // Leer posición actual
-        int my_read_idx = data->receivers[my_slot].read_index;
+        char decrypted_char;
+
+        // El carril urgente siempre se revisa primero
+        if (sem_trywait(&receivers[my_slot].urgent_available) == 0) {
+            int my_read_idx = receivers[my_slot].urgent_read_index;
+            sem_wait(&data->urgent_mutex);
+
+            buffer_entry* entry = &data->urgent_buffer[my_read_idx];
+            decrypted_char = entry->ascii_val ^ key;
+            long long latency_ns = monotonic_ns() - entry->publish_ns;
+            int reads_after = __sync_sub_and_fetch(&entry->read_count, 1);
+
+            print_char_info("Receptor", getpid(), decrypted_char, my_read_idx, entry->timestamp);
+            printf("      * Carril urgente, latencia %.1f us.\n", latency_ns / 1000.0);
+
+            // El último lector libera el espacio del carril urgente
+            if (reads_after == 0) sem_post(&data->urgent_empty_slots);
+
+            sem_post(&data->urgent_mutex);
+            receivers[my_slot].urgent_read_index = (my_read_idx + 1) % PRIORITY_LANE_SIZE;
+        } else {
+            // Leer posición actual
+            int my_read_idx = receivers[my_slot].read_index;
         
-        // Bloquear acceso al slot
-        sem_t* slot_mutexes = get_slot_mutexes(data);
-        sem_wait(&slot_mutexes[my_read_idx]);
+            // Bloquear acceso al slot
+            sem_t* slot_mutexes = get_slot_mutexes(data);
+            sem_wait(&slot_mutexes[my_read_idx]);
         
-        // Descifrar carácter
-        char decrypted_char = data->buffer[my_read_idx].ascii_val ^ key;
-        time_t insertion_time = data->buffer[my_read_idx].timestamp;
+            // Descifrar carácter
+            decrypted_char = data->buffer[my_read_idx].ascii_val ^ key;
+            time_t insertion_time = data->buffer[my_read_idx].timestamp;
                 
-        // Decrementar cantidad de lectores restantes
-        int reads_after = __sync_sub_and_fetch(&data->buffer[my_read_idx].read_count, 1);
+            // Decrementar cantidad de lectores restantes
+            int reads_after = __sync_sub_and_fetch(&data->buffer[my_read_idx].read_count, 1);
 
-        // Mostrar información
-        print_char_info("Receptor", getpid(), decrypted_char, my_read_idx, insertion_time);
+            // Mostrar información
+            print_char_info("Receptor", getpid(), decrypted_char, my_read_idx, insertion_time);
 
-        // Si es el último lector, liberar el espacio
-        if (reads_after == 0) {
-            printf("      * Último lector: Búfer[%d] liberado.\n", my_read_idx);
-            sem_post(&data->empty_slots);
-        } else {
-            printf("      * Faltan %d lectores[%d].\n", reads_after, my_read_idx);
-        }
+            // Si es el último lector, liberar el espacio
+            if (reads_after == 0) {
+                printf("      * Último lector: Búfer[%d] liberado.\n", my_read_idx);
+                sem_post(&data->empty_slots);
+            } else {
+                printf("      * Faltan %d lectores[%d].\n", reads_after, my_read_idx);
+            }
 
-        // Liberar el slot
-        sem_post(&slot_mutexes[my_read_idx]);
+            // Liberar el slot
+            sem_post(&slot_mutexes[my_read_idx]);
         
-        // Avanzar al siguiente índice
-        data->receivers[my_slot].read_index = (my_read_idx + 1) % data->buffer_size;
+            // Avanzar al siguiente índice
+            receivers[my_slot].read_index = (my_read_idx + 1) % data->buffer_size;
+        }
 
         // Escribir en el archivo
         fputc(decrypted_char, output_file);
         fflush(output_file);
+        received_chars++;
 
         // Espera automática
         if (!is_manual) {
@@ -157,15 +306,26 @@ int main(int argc, char *argv[]) {
     // Eliminar receptor del registro
     sem_wait(&data->receiver_registry_mutex);
     if(my_slot != -1) {
-        data->receivers[my_slot].pid = 0;
+        receivers[my_slot].pid = 0;
+        receivers[my_slot].uses_eventfd = 0;
         data->active_receivers--;
     }
     sem_post(&data->receiver_registry_mutex);
 
+    // Publicar estadísticas antes de avisar al finalizador
+    if (use_perf) perf_counters_stop(&perf, data, 0, received_chars);
+
     // Notificar finalización
     sem_post(&data->process_finished);
     
     printf("Receptor (PID %d) finalizando.\n", getpid());
+    if (use_eventfd) {
+        shutdown(server.listen_fd, SHUT_RDWR);
+        pthread_join(server_thread, NULL);
+        close(server.listen_fd);
+    }
+    if (event_fd != -1) close(event_fd);
+    if (epoll_fd != -1) close(epoll_fd);
     fclose(output_file);
     munmap(data, shm_size);
 
@@ -0,0 +1,289 @@
+#include "shared_memory.h"
+#include <pthread.h>
+
+// Lee la siguiente entrada del carril urgente del anillo padre
+static void read_urgent_entry(shared_data* ring, receiver_info* me, buffer_entry* out) {
+    int read_idx = me->urgent_read_index;
+    sem_wait(&ring->urgent_mutex);
+    *out = ring->urgent_buffer[read_idx];
+    if (__sync_sub_and_fetch(&ring->urgent_buffer[read_idx].read_count, 1) == 0) {
+        sem_post(&ring->urgent_empty_slots);
+    }
+    sem_post(&ring->urgent_mutex);
+    me->urgent_read_index = (read_idx + 1) % PRIORITY_LANE_SIZE;
+}
+
+// Lee la siguiente entrada del búfer principal del anillo padre
+static void read_bulk_entry(shared_data* ring, receiver_info* me, buffer_entry* out) {
+    int read_idx = me->read_index;
+    sem_t* slot_mutexes = get_slot_mutexes(ring);
+    sem_wait(&slot_mutexes[read_idx]);
+    *out = ring->buffer[read_idx];
+    if (__sync_sub_and_fetch(&ring->buffer[read_idx].read_count, 1) == 0) {
+        sem_post(&ring->empty_slots);
+    }
+    sem_post(&slot_mutexes[read_idx]);
+    me->read_index = (read_idx + 1) % ring->buffer_size;
+}
+
+// Publica una entrada ya cifrada en el anillo hijo, igual que un emisor.
+// Devuelve -1 si la espera por espacio fue interrumpida o se está apagando.
+static int publish_entry(shared_data* ring, notify_cache* notify_fds, const buffer_entry* in, int is_urgent) {
+    sem_t* free_slots = is_urgent ? &ring->urgent_empty_slots : &ring->empty_slots;
+    if (sem_wait(free_slots) == -1 || !keep_running) return -1;
+
+    // Obtener eventfd de receptores nuevos antes de tomar el registro
+    notify_cache_refresh(notify_fds, ring);
+    sem_wait(&ring->receiver_registry_mutex);
+
+    buffer_entry* entry;
+    sem_t* entry_mutex;
+    int write_idx;
+    if (is_urgent) {
+        entry_mutex = &ring->urgent_mutex;
+        sem_wait(entry_mutex);
+        write_idx = ring->urgent_write_index;
+        ring->urgent_write_index = (ring->urgent_write_index + 1) % PRIORITY_LANE_SIZE;
+        entry = &ring->urgent_buffer[write_idx];
+    } else {
+        sem_wait(&ring->producer_mutex);
+        write_idx = ring->write_index;
+        ring->write_index = (ring->write_index + 1) % ring->buffer_size;
+        sem_post(&ring->producer_mutex);
+
+        entry_mutex = &get_slot_mutexes(ring)[write_idx];
+        sem_wait(entry_mutex);
+        entry = &ring->buffer[write_idx];
+    }
+
+    // Se conserva la hora de publicación original para medir latencia de punta a punta
+    entry->ascii_val = in->ascii_val;
+    entry->index = write_idx;
+    entry->timestamp = in->timestamp;
+    entry->publish_ns = in->publish_ns;
+    entry->read_count = ring->active_receivers;
+    sem_post(entry_mutex);
+    ring->total_chars_transferred++;
+
+    // Notificar a receptores hijos o liberar slot
+    if (ring->active_receivers == 0) {
+        sem_post(free_slots);
+    } else {
+        receiver_info* receivers = get_receivers(ring);
+        for (int i = 0; i < ring->max_receivers; i++) {
+            if (receivers[i].pid != 0) {
+                notify_new_entry(notify_fds, &receivers[i], i, is_urgent);
+            }
+        }
+    }
+
+    sem_post(&ring->receiver_registry_mutex);
+    return 0;
+}
+
+// Estado del hilo que reenvía el carril urgente
+typedef struct {
+    shared_data* parent;
+    shared_data* child;
+    receiver_info* me;
+    notify_cache notify_fds;
+    long forwarded;
+} urgent_forwarder;
+
+// Reenvía el carril urgente por separado, para que un búfer principal lleno
+// en el anillo hijo nunca retenga mensajes urgentes en este relevo
+static void* forward_urgent(void* arg) {
+    urgent_forwarder* fw = arg;
+    while (keep_running && !fw->parent->shutdown_requested) {
+        if (sem_wait(&fw->me->urgent_available) == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (!keep_running || fw->parent->shutdown_requested) break;
+
+        buffer_entry entry;
+        read_urgent_entry(fw->parent, fw->me, &entry);
+        if (publish_entry(fw->child, &fw->notify_fds, &entry, 1) == -1) break;
+        fw->forwarded++;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    // Validar argumentos
+    if (argc != 5) {
+        fprintf(stderr, "Uso: %s <anillo_padre> <anillo_hijo> <cantidad_espacios> <abanico>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* parent_name = argv[1];
+    const char* child_name = argv[2];
+    int buffer_size = atoi(argv[3]);
+    int fanout = atoi(argv[4]);
+
+    if (strlen(parent_name) >= MAX_RING_NAME || strlen(child_name) >= MAX_RING_NAME
+        || strcmp(parent_name, child_name) == 0) {
+        fprintf(stderr, "Los nombres de anillo deben ser distintos (max %d caracteres).\n", MAX_RING_NAME - 1);
+        return EXIT_FAILURE;
+    }
+    if (buffer_size <= 0 || buffer_size > MAX_BUFFER_SIZE) {
+        fprintf(stderr, "La cantidad de espacios debe ser un entero positivo (max %d).\n", MAX_BUFFER_SIZE);
+        return EXIT_FAILURE;
+    }
+    if (fanout <= 0 || fanout > MAX_RECEIVERS_LIMIT) {
+        fprintf(stderr, "El abanico debe ser un entero positivo (max %d).\n", MAX_RECEIVERS_LIMIT);
+        return EXIT_FAILURE;
+    }
+
+    // Abrir el anillo padre
+    size_t parent_size;
+    shared_data* parent = map_shared_data(parent_name, "Relevo", &parent_size);
+    if (!parent) {
+        return EXIT_FAILURE;
+    }
+
+    // Crear el anillo hijo donde se suscriben los receptores; nunca reemplaza uno existente
+    size_t child_size;
+    shared_data* child = create_shared_data(child_name, buffer_size, fanout, 1, &child_size);
+    if (!child) {
+        munmap(parent, parent_size);
+        return EXIT_FAILURE;
+    }
+
+    // Manejar señal de terminación
+    signal(SIGTERM, sigterm_handler);
+
+    // Registrarse como un receptor más del anillo padre
+    receiver_info* parent_receivers = get_receivers(parent);
+    int my_slot = -1;
+    sem_wait(&parent->receiver_registry_mutex);
+    for (int i = 0; i < parent->max_receivers; ++i) {
+        if (parent_receivers[i].pid == 0) {
+            my_slot = i;
+            parent_receivers[i].uses_eventfd = 0;
+            parent_receivers[i].split_lanes = 1;
+            parent_receivers[i].pid = getpid();
+            parent_receivers[i].read_index = parent->write_index;
+            parent_receivers[i].urgent_read_index = parent->urgent_write_index;
+            parent_receivers[i].is_manual = 0;
+            break;
+        }
+    }
+    if (my_slot != -1) {
+        parent->total_receivers++;
+        parent->active_receivers++;
+    }
+    sem_post(&parent->receiver_registry_mutex);
+
+    // Se sale si no hay espacio
+    if (my_slot == -1) {
+        fprintf(stderr, "No hay slots disponibles en el anillo '%s'\n", parent_name);
+        destroy_shared_data(child);
+        munmap(child, child_size);
+        shm_unlink(child_name);
+        munmap(parent, parent_size);
+        return EXIT_FAILURE;
+    }
+    receiver_info* me = &parent_receivers[my_slot];
+
+    notify_cache notify_fds;
+    if (notify_cache_init(&notify_fds, fanout) == -1) {
+        fprintf(stderr, "Relevo: sin memoria para los eventfd, solo se usarán semáforos\n");
+    }
+
+    // Hilo del carril urgente, con su propia copia de los eventfd.
+    // SIGTERM lo atiende solo el hilo principal.
+    urgent_forwarder urgent = { .parent = parent, .child = child, .me = me, .forwarded = 0 };
+    if (notify_cache_init(&urgent.notify_fds, fanout) == -1) {
+        fprintf(stderr, "Relevo: sin memoria para los eventfd urgentes, solo se usarán semáforos\n");
+    }
+    sigset_t term_set, old_set;
+    sigemptyset(&term_set);
+    sigaddset(&term_set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &term_set, &old_set);
+    pthread_t urgent_thread;
+    int thread_error = pthread_create(&urgent_thread, NULL, forward_urgent, &urgent);
+    pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+    if (thread_error != 0) {
+        fprintf(stderr, "Relevo: no se pudo crear el hilo urgente: %s\n", strerror(thread_error));
+        keep_running = 0;
+    }
+
+    printf("Relevo (PID %d): %s%s%s -> %s%s%s (abanico %d, %d espacios)\n",
+           getpid(), COLOR_SUCCESS, parent_name, COLOR_RESET,
+           COLOR_SUCCESS, child_name, COLOR_RESET, fanout, buffer_size);
+
+    // Bucle principal: reenviar el búfer principal sin descifrar.
+    // data_available solo cuenta entradas del búfer principal (split_lanes).
+    long forwarded = 0;
+    while (keep_running && !parent->shutdown_requested) {
+        if (sem_wait(&me->data_available) == -1) {
+            if (keep_running && !parent->shutdown_requested) perror("sem_wait data_available");
+            break;
+        }
+        if (!keep_running || parent->shutdown_requested) break;
+
+        buffer_entry entry;
+        read_bulk_entry(parent, me, &entry);
+        if (publish_entry(child, &notify_fds, &entry, 0) == -1) {
+            if (keep_running && !parent->shutdown_requested) perror("sem_wait empty_slots");
+            break;
+        }
+        forwarded++;
+    }
+
+    // Detener el hilo urgente, esté esperando al padre o espacio en el hijo
+    keep_running = 0;
+    if (thread_error == 0) {
+        sem_post(&me->urgent_available);
+        for (int i = 0; i < PRIORITY_LANE_SIZE; i++) {
+            sem_post(&child->urgent_empty_slots);
+        }
+        pthread_join(urgent_thread, NULL);
+    }
+    notify_cache_close(&urgent.notify_fds);
+    forwarded += urgent.forwarded;
+
+    // Propagar el apagado al anillo hijo
+    child->shutdown_requested = 1;
+    receiver_info* child_receivers = get_receivers(child);
+    sem_wait(&child->receiver_registry_mutex);
+    int child_processes = child->active_receivers;
+    for (int i = 0; i < child->max_receivers; i++) {
+        if (child_receivers[i].pid != 0) {
+            notify_receiver(&notify_fds, &child_receivers[i], i);
+            kill(child_receivers[i].pid, SIGTERM);
+        }
+    }
+    sem_post(&child->receiver_registry_mutex);
+    notify_cache_close(&notify_fds);
+
+    // Esperar a los receptores hijos
+    for (int i = 0; i < child_processes; i++) {
+        while (sem_wait(&child->process_finished) == -1 && errno == EINTR) {}
+    }
+
+    // Subir las estadísticas del anillo hijo para que el finalizador las vea
+    int child_stats = child->stats_count < MAX_STATS ? child->stats_count : MAX_STATS;
+    for (int i = 0; i < child_stats; i++) {
+        int slot = __sync_fetch_and_add(&parent->stats_count, 1);
+        if (slot >= MAX_STATS) break;
+        parent->stats[slot] = child->stats[i];
+    }
+
+    destroy_shared_data(child);
+    munmap(child, child_size);
+    shm_unlink(child_name);
+
+    // Eliminar el relevo del registro del padre
+    sem_wait(&parent->receiver_registry_mutex);
+    me->pid = 0;
+    parent->active_receivers--;
+    sem_post(&parent->receiver_registry_mutex);
+
+    sem_post(&parent->process_finished);
+
+    printf("Relevo (PID %d) finalizando, %ld caracteres reenviados.\n", getpid(), forwarded);
+    munmap(parent, parent_size);
+
+    return EXIT_SUCCESS;
+}
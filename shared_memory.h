@@ -12,11 +12,25 @@
 #include <semaphore.h>
 #include <signal.h>
 #include <time.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
 
 #define SHM_NAME "mem"
 #define MAX_BUFFER_SIZE 256
-#define MAX_RECEIVERS 50
+#define MAX_RECEIVERS 50          // Abanico por defecto de cada anillo
+#define MAX_RECEIVERS_LIMIT 4096  // Abanico máximo configurable
+#define MAX_RING_NAME 64
+#define NOTIFY_RECHECK_MS 200     // Espera máxima en epoll antes de revisar el semáforo
+#define NOTIFY_FETCH_MS 100       // Espera máxima para recibir el eventfd de un receptor
 #define MAX_FILE_SIZE 4096
+#define MAX_STATS 100
+#define PRIORITY_LANE_SIZE 8
 
 // Codigos de color ANSI
 #define COLOR_RESET     "\033[0m"
@@ -48,15 +62,37 @@ typedef struct {
     char ascii_val;       // Carácter almacenado
     int index;            // Posición en el búfer
     time_t timestamp;     // Momento en que se guardó
+    long long publish_ns; // Momento de publicación (CLOCK_MONOTONIC)
     volatile int read_count; // Cantidad de receptores que lo han leído
 } buffer_entry;
 
+// Contadores de rendimiento que cada proceso publica al terminar
+typedef struct {
+    pid_t pid;                        // PID del proceso (0 si el slot está libre)
+    int is_emitter;                   // 1 emisor, 0 receptor
+    int counters_open;                // Bits de los eventos de perf que se abrieron
+    int user_only;                    // Bits de los eventos contados solo en modo usuario
+    int llc_generic;                  // LLC medido con el evento genérico de fallos de caché
+    long chars;                       // Caracteres enviados o recibidos
+    unsigned long long cycles;        // Ciclos de CPU
+    unsigned long long instructions;  // Instrucciones ejecutadas
+    unsigned long long llc_misses;    // Fallos de la caché de último nivel
+    unsigned long long context_switches;
+    unsigned long long page_faults;
+    unsigned long long cpu_time_ns;   // Tiempo de CPU del proceso
+} process_stats;
+
 // Información de cada receptor registrado
 typedef struct {
     pid_t pid;            // PID del receptorDame este codigo con comentarios, no los hagas muy elaborados
     int read_index;       // Posición actual de lectura
     int is_manual;        // Indica si el receptor es manual
-    sem_t data_available; // Semáforo de datos disponibles
+    sem_t data_available; // Semáforo de datos disponibles (ambos carriles)
+    sem_t urgent_available; // Datos pendientes en el carril urgente
+    int urgent_read_index;  // Posición de lectura en el carril urgente
+    int uses_eventfd;     // El receptor espera en epoll y sirve su eventfd por socket
+    int split_lanes;      // Urgentes solo por urgent_available (relevos con hilo urgente)
+    volatile int notify_fallback; // Algún emisor no pudo obtener el eventfd
 } receiver_info;
 
 // Estructura principal de la memoria compartida
@@ -77,23 +113,354 @@ typedef struct {
     int source_size;
     int source_read_index;
 
-    // Información de receptores
-    receiver_info receivers[MAX_RECEIVERS];
+    // Información de receptores (la tabla va después de los mutex por slot)
+    int max_receivers;              // Abanico del anillo, fijado al inicializar
     int total_emitters;
     int active_emitters;
     int total_receivers;
     int active_receivers;
     long total_chars_transferred;   // Estadística de caracteres enviados
 
+    // Carril urgente: no depende de empty_slots del búfer principal
+    sem_t urgent_empty_slots;       // Espacios vacíos del carril urgente
+    sem_t urgent_mutex;             // Protege el carril urgente
+    int urgent_write_index;
+    buffer_entry urgent_buffer[PRIORITY_LANE_SIZE];
+
+    // Estadísticas por proceso (opción 'perf')
+    process_stats stats[MAX_STATS];
+    int stats_count;
+
     // Búfer de datos dinámico
     buffer_entry buffer[];
 } shared_data;
 
+// Tamaño total de un anillo: encabezado, búfer, mutex por slot y tabla de receptores
+static inline size_t shared_data_size(int buffer_size, int max_receivers) {
+    return sizeof(shared_data)
+         + buffer_size * sizeof(buffer_entry)
+         + buffer_size * sizeof(sem_t)
+         + max_receivers * sizeof(receiver_info);
+}
+
 // Calcula la dirección donde inician los semáforos por slot
 static inline sem_t* get_slot_mutexes(shared_data* data) {
     return (sem_t*) &data->buffer[data->buffer_size];
 }
 
+// Calcula la dirección de la tabla de receptores
+static inline receiver_info* get_receivers(shared_data* data) {
+    return (receiver_info*) &get_slot_mutexes(data)[data->buffer_size];
+}
+
+// Abre y mapea un anillo existente. Devuelve NULL si falla.
+static inline shared_data* map_shared_data(const char* name, const char* who, size_t* shm_size) {
+    int shm_fd = shm_open(name, O_RDWR, 0666);
+    if (shm_fd == -1) {
+        fprintf(stderr, "%s: shm_open de '%s' falló: %s\n", who, name, strerror(errno));
+        return NULL;
+    }
+
+    // Mapeo temporal para obtener tamaño real
+    shared_data* temp_map = mmap(0, sizeof(shared_data), PROT_READ, MAP_SHARED, shm_fd, 0);
+    if (temp_map == MAP_FAILED) {
+        fprintf(stderr, "%s: mmap temporal falló: %s\n", who, strerror(errno));
+        close(shm_fd);
+        return NULL;
+    }
+    *shm_size = shared_data_size(temp_map->buffer_size, temp_map->max_receivers);
+    munmap(temp_map, sizeof(shared_data));
+
+    // Mapeo completo
+    shared_data* data = mmap(0, *shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    close(shm_fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "%s: mmap final falló: %s\n", who, strerror(errno));
+        return NULL;
+    }
+    return data;
+}
+
+// Crea un anillo vacío con sus semáforos. Lo usan el inicializador y los relevos.
+// Con exclusive falla si el nombre ya existe en lugar de reemplazarlo, para
+// que un relevo nunca borre un anillo vivo.
+static inline shared_data* create_shared_data(const char* name, int buffer_size,
+                                              int max_receivers, int exclusive,
+                                              size_t* shm_size) {
+    // El inicializador elimina memoria compartida previa con el mismo nombre
+    if (!exclusive) shm_unlink(name);
+    *shm_size = shared_data_size(buffer_size, max_receivers);
+
+    int shm_fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (shm_fd == -1) {
+        if (errno == EEXIST) {
+            fprintf(stderr, "El anillo '%s' ya existe.\n", name);
+        } else {
+            perror("No se pudo crear la memoria compartida");
+        }
+        return NULL;
+    }
+    if (ftruncate(shm_fd, *shm_size) == -1) {
+        perror("No se pudo establecer el tamaño de la memoria compartida");
+        close(shm_fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    shared_data *data = mmap(0, *shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    close(shm_fd);
+    if (data == MAP_FAILED) {
+        perror("No se pudo mapear la memoria compartida");
+        shm_unlink(name);
+        return NULL;
+    }
+
+    // Inicializa variables de control (ftruncate deja todo en cero)
+    data->buffer_size = buffer_size;
+    data->max_receivers = max_receivers;
+
+    // Inicializa información de receptores
+    receiver_info* receivers = get_receivers(data);
+    for (int i = 0; i < max_receivers; ++i) {
+        // Semáforos para notificar a cada receptor
+        if (sem_init(&receivers[i].data_available, 1, 0) == -1
+            || sem_init(&receivers[i].urgent_available, 1, 0) == -1) {
+            perror("Error al inicializar semáforo de receptor");
+            munmap(data, *shm_size);
+            shm_unlink(name);
+            return NULL;
+        }
+    }
+
+    // Inicializa un semáforo (mutex) por cada espacio del buffer
+    sem_t *slot_mutexes = get_slot_mutexes(data);
+    for (int i = 0; i < buffer_size; i++) {
+        if (sem_init(&slot_mutexes[i], 1, 1) == -1) {
+            perror("Error al inicializar un mutex de slot");
+            munmap(data, *shm_size);
+            shm_unlink(name);
+            return NULL;
+        }
+    }
+
+    // Inicializa semáforos globales
+    if (sem_init(&data->empty_slots, 1, buffer_size) == -1          // comienza con todos los espacios libres
+        || sem_init(&data->producer_mutex, 1, 1) == -1
+        || sem_init(&data->receiver_registry_mutex, 1, 1) == -1
+        || sem_init(&data->process_finished, 1, 0) == -1
+        || sem_init(&data->urgent_empty_slots, 1, PRIORITY_LANE_SIZE) == -1
+        || sem_init(&data->urgent_mutex, 1, 1) == -1) {
+        perror("Error al inicializar semáforos globales");
+        munmap(data, *shm_size);
+        shm_unlink(name);
+        return NULL;
+    }
+    return data;
+}
+
+// Destruye los semáforos de un anillo antes de liberarlo
+static inline void destroy_shared_data(shared_data* data) {
+    sem_destroy(&data->empty_slots);
+    sem_destroy(&data->producer_mutex);
+    sem_destroy(&data->receiver_registry_mutex);
+    sem_destroy(&data->process_finished);
+    sem_destroy(&data->urgent_empty_slots);
+    sem_destroy(&data->urgent_mutex);
+
+    // Destruir semáforos de receptores
+    receiver_info* receivers = get_receivers(data);
+    for (int i = 0; i < data->max_receivers; ++i) {
+        sem_destroy(&receivers[i].data_available);
+        sem_destroy(&receivers[i].urgent_available);
+    }
+
+    // Destruir semáforos por cada slot del búfer
+    sem_t* slot_mutexes = get_slot_mutexes(data);
+    for (int i = 0; i < data->buffer_size; ++i) {
+        sem_destroy(&slot_mutexes[i]);
+    }
+}
+
+// Reloj monotónico en nanosegundos para medir latencias
+static inline long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Copias locales de los eventfd de los receptores, una por slot
+typedef struct {
+    int size;
+    pid_t* pid; // Dueño del fd copiado
+    int* fd;    // fd local (-1 si no se pudo obtener)
+} notify_cache;
+
+static inline int notify_cache_init(notify_cache* cache, int size) {
+    cache->size = size;
+    cache->pid = malloc(size * sizeof(pid_t));
+    cache->fd = malloc(size * sizeof(int));
+    if (!cache->pid || !cache->fd) {
+        free(cache->pid);
+        free(cache->fd);
+        cache->size = 0;
+        cache->pid = NULL;
+        cache->fd = NULL;
+        return -1;
+    }
+    for (int i = 0; i < size; i++) {
+        cache->pid[i] = 0;
+        cache->fd[i] = -1;
+    }
+    return 0;
+}
+
+static inline void notify_cache_close(notify_cache* cache) {
+    for (int i = 0; i < cache->size; i++) {
+        if (cache->fd[i] != -1) close(cache->fd[i]);
+    }
+    free(cache->pid);
+    free(cache->fd);
+    cache->size = 0;
+    cache->pid = NULL;
+    cache->fd = NULL;
+}
+
+// Dirección del socket abstracto donde cada receptor entrega su eventfd
+static inline socklen_t notify_socket_addr(pid_t pid, struct sockaddr_un* addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    int len = snprintf(addr->sun_path + 1, sizeof(addr->sun_path) - 1, "sync-process-comms-%d", pid);
+    return offsetof(struct sockaddr_un, sun_path) + 1 + len;
+}
+
+// Verifica que el otro extremo del socket sea del mismo usuario y,
+// si se indica, que sea el proceso esperado
+static inline int check_peer_cred(int sock, pid_t expected_pid) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1) return -1;
+    if (cred.uid != geteuid() || (expected_pid != 0 && cred.pid != expected_pid)) {
+        errno = EACCES;
+        return -1;
+    }
+    return 0;
+}
+
+// Pide el eventfd al receptor por su socket (SCM_RIGHTS), sin permisos de ptrace.
+// No bloquea más de NOTIFY_FETCH_MS aunque el receptor esté detenido.
+static inline int fetch_remote_fd(pid_t pid) {
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (sock == -1) return -1;
+
+    // Con socket no bloqueante, connect falla con EAGAIN si la cola está llena
+    struct sockaddr_un addr;
+    socklen_t addr_len = notify_socket_addr(pid, &addr);
+    if (connect(sock, (struct sockaddr*)&addr, addr_len) == -1) {
+        close(sock);
+        return -1;
+    }
+
+    // El nombre abstracto lo puede ocupar cualquiera: exigir el receptor real
+    if (check_peer_cred(sock, pid) == -1) {
+        close(sock);
+        return -1;
+    }
+
+    struct pollfd pfd = { .fd = sock, .events = POLLIN };
+    int ready = poll(&pfd, 1, NOTIFY_FETCH_MS);
+    if (ready <= 0) {
+        if (ready == 0) errno = ETIMEDOUT;
+        close(sock);
+        return -1;
+    }
+
+    char byte;
+    struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg = {
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = control.buf, .msg_controllen = sizeof(control.buf)
+    };
+    ssize_t n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    close(sock);
+    if (n <= 0) {
+        if (n == 0) errno = ECONNRESET;
+        return -1;
+    }
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        errno = EPROTO;
+        return -1;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+// Obtiene los eventfd de receptores nuevos. Se llama SIN receiver_registry_mutex
+// para que un receptor lento o detenido no bloquee al resto del canal.
+// Cada (slot, pid) se intenta una sola vez; un fallo queda guardado como fd -1.
+static inline void notify_cache_refresh(notify_cache* cache, shared_data* data) {
+    receiver_info* receivers = get_receivers(data);
+    int limit = data->max_receivers < cache->size ? data->max_receivers : cache->size;
+    for (int i = 0; i < limit; i++) {
+        pid_t pid = receivers[i].pid;
+        if (pid == 0 || !receivers[i].uses_eventfd || cache->pid[i] == pid) continue;
+
+        if (cache->fd[i] != -1) close(cache->fd[i]);
+        cache->pid[i] = pid;
+        cache->fd[i] = fetch_remote_fd(pid);
+        if (cache->fd[i] == -1) {
+            fprintf(stderr, "%sNo se pudo obtener el eventfd del receptor %d: %s%s\n",
+                    COLOR_WARNING, pid, strerror(errno), COLOR_RESET);
+        }
+    }
+}
+
+// Notifica al receptor del slot: siempre el semáforo y, si lo pidió, su eventfd.
+// Si el eventfd no se pudo obtener se marca notify_fallback para que el
+// receptor vuelva a sem_wait. Se llama con receiver_registry_mutex tomado.
+static inline void notify_receiver(notify_cache* cache, receiver_info* r, int slot) {
+    if (!r->uses_eventfd) {
+        sem_post(&r->data_available);
+        return;
+    }
+
+    // Receptor registrado después del último refresco: basta el semáforo,
+    // epoll_wait lo revisa cada NOTIFY_RECHECK_MS
+    int fd = -1;
+    if (slot < cache->size && cache->pid[slot] == r->pid) {
+        fd = cache->fd[slot];
+        if (fd == -1) r->notify_fallback = 1;
+    } else if (slot >= cache->size) {
+        r->notify_fallback = 1;
+    }
+
+    // La marca de respaldo queda escrita antes del sem_post
+    sem_post(&r->data_available);
+    if (fd != -1) {
+        uint64_t one = 1;
+        if (write(fd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+            perror("write eventfd");
+        }
+    }
+}
+
+// Avisa al receptor del slot de una entrada nueva en el carril indicado.
+// urgent_available va antes que data_available para que el receptor lo vea primero;
+// los relevos atienden el carril urgente en su propio hilo y no cuentan
+// esas entradas en data_available.
+static inline void notify_new_entry(notify_cache* cache, receiver_info* r, int slot, int is_urgent) {
+    if (is_urgent) {
+        sem_post(&r->urgent_available);
+        if (r->split_lanes) return;
+    }
+    notify_receiver(cache, r, slot);
+}
+
 // Función para imprimir información de cada carácter procesado
 static inline void print_char_info(const char* role, pid_t pid, char c, int index, time_t ts) {
     char time_str[10];